@@ -28,6 +28,7 @@ ScifiDisplayBase::ScifiDisplayBase(int num_boards, ScifiDisplayBoard* board0,
   boards_[1] = board1;
   boards_[2] = board2;
   boards_[3] = board3;
+  trace_ = 0;
 }
 
 ScifiDisplayBoard* ScifiDisplayBase::get_board(int board) const {
@@ -57,6 +58,9 @@ static inline int board_as_int(char board) {
 }
 
 bool ScifiDisplayBase::process_command(const char* command, char* response, unsigned int current_millis) {
+  if(trace_)
+    trace_->command(current_millis, command);
+
   static const int MAX_ARGS = 5;
   const char* argv[MAX_ARGS];
   argv[0] = command;
@@ -146,6 +150,9 @@ invalid_args:
 }
 
 void ScifiDisplayBase::update(unsigned int current_millis) {
+  if(trace_)
+    trace_->update(current_millis);
+
   for(int i = 0; i < num_boards_; ++i) {
     ScifiDisplayBoard* board = boards_[i];
 
@@ -162,6 +169,14 @@ void ScifiDisplayBase::update(unsigned int current_millis) {
   }
 }
 
+void ScifiDisplayBase::set_trace(ScifiDisplayTrace* trace) {
+  trace_ = trace;
+  if(trace_)
+    trace_->start(num_boards_);
+  for(int i = 0; i < num_boards_; ++i)
+    boards_[i]->set_trace(trace, i);
+}
+
 bool ScifiDisplayBase::board_ok(int board) const {
   return (board >= 0 && board < num_boards_);
 }
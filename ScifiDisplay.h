@@ -86,6 +86,13 @@ class ScifiDisplayBase {
      */
     void update(unsigned int current_millis);
 
+    /**
+     * Report all commands, updates, inputs, and bus writes to trace, or stop
+     * if trace is NULL.  Direct calls into the boards aren't reported, so
+     * while tracing, make any changes through process_command().
+     */
+    void set_trace(ScifiDisplayTrace* trace);
+
   private:
     // Apologies for this template ugliness.  It makes the command parser much
     // easier to write.
@@ -109,6 +116,7 @@ class ScifiDisplayBase {
 
     int num_boards_;
     ScifiDisplayBoard* boards_[MAX_BOARDS];
+    ScifiDisplayTrace* trace_;
 };
 
 /**
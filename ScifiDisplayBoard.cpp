@@ -29,6 +29,9 @@ static const int COLOR_RED = 2;
 
 ScifiDisplayBoard::ScifiDisplayBoard(int data_pin, int clock_pin, int strobe_pin)
     : board_((byte)data_pin, (byte)clock_pin, (byte)strobe_pin) {
+  trace_ = 0;
+  trace_index_ = 0;
+
   reported_buttons_ = 0u;
 
   for(int i = 0; i < NUM_DIGITS; ++i)
@@ -37,12 +40,12 @@ ScifiDisplayBoard::ScifiDisplayBoard(int data_pin, int clock_pin, int strobe_pin
 
   leds_state_ = -1;
 
-  board_.clearDisplay();
-  board_.setLEDs((word)0);
+  clear_display();
+  set_leds((word)0);
 }
 
 void ScifiDisplayBoard::set_brightness(int brightness) {
-  board_.setupDisplay(brightness > 0, (byte)(brightness - 1));
+  setup_display(brightness > 0, (byte)(brightness - 1));
 }
 
 static inline bool message_index_ok(int index) {
@@ -84,13 +87,13 @@ void ScifiDisplayBoard::flash_message(int index, unsigned int current_millis) {
   message_state_ = 0;
   message_state_change_millis_ = current_millis;
 
-  board_.clearDisplay();
+  clear_display();
 }
 
 void ScifiDisplayBoard::disable_message() {
   message_state_ = -1;
 
-  board_.clearDisplay();
+  clear_display();
 }
 
 bool ScifiDisplayBoard::get_leds_state(bool* blinking_out, bool* green_out) const {
@@ -102,7 +105,7 @@ bool ScifiDisplayBoard::get_leds_state(bool* blinking_out, bool* green_out) cons
 }
 
 void ScifiDisplayBoard::blink_leds(bool green, unsigned int current_millis) {
-  leds_value_ = (unsigned int)(random() & 0xff);
+  leds_value_ = (unsigned int)(next_random() & 0xff);
   leds_color_ = (green ? COLOR_GREEN : COLOR_RED);
   leds_state_ = 2;
   leds_state_change_millis_ = current_millis;
@@ -117,13 +120,13 @@ void ScifiDisplayBoard::flash_leds(bool green, unsigned int current_millis) {
   leds_state_ = 0;
   leds_state_change_millis_ = current_millis;
 
-  board_.setLEDs((word)0);
+  set_leds((word)0);
 }
 
 void ScifiDisplayBoard::disable_leds() {
   leds_state_ = -1;
 
-  board_.setLEDs((word)0);
+  set_leds((word)0);
 }
 
 unsigned int ScifiDisplayBoard::update(unsigned int current_millis) {
@@ -141,9 +144,9 @@ unsigned int ScifiDisplayBoard::update(unsigned int current_millis) {
     message_state_ = !message_state_;
 
     if(message_state_)
-      board_.setDisplayToString(messages_[message_index_]);
+      set_display_to_string(messages_[message_index_]);
     else
-      board_.clearDisplay();
+      clear_display();
   }
 
   if(leds_state_ >= 0
@@ -151,7 +154,7 @@ unsigned int ScifiDisplayBoard::update(unsigned int current_millis) {
     leds_state_change_millis_ += LEDS_STATE_DURATION[leds_state_];
 
     if(leds_state_ == 2) {
-      int flip = (int)(random() & (NUM_DIGITS - 1));
+      int flip = (int)(next_random() & (NUM_DIGITS - 1));
       leds_value_ ^= (1u << flip);
 
       update_led(flip);
@@ -160,9 +163,9 @@ unsigned int ScifiDisplayBoard::update(unsigned int current_millis) {
       leds_state_ = !leds_state_;
 
       if(leds_state_)
-        board_.setLEDs(leds_color_ == COLOR_GREEN ? (word)0xff : (word)0xff00);
+        set_leds(leds_color_ == COLOR_GREEN ? (word)0xff : (word)0xff00);
       else
-        board_.setLEDs(0);
+        set_leds(0);
     }
   }
 
@@ -170,7 +173,7 @@ unsigned int ScifiDisplayBoard::update(unsigned int current_millis) {
 }
 
 void ScifiDisplayBoard::update_led(int index) {
-  board_.setLED(
+  set_led(
     ((leds_value_ & (1u << index)) ? (byte)leds_color_ : 0),
     (byte)index
   );
@@ -178,7 +181,49 @@ void ScifiDisplayBoard::update_led(int index) {
 
 unsigned int ScifiDisplayBoard::get_button_presses() {
   unsigned int buttons = (unsigned int)board_.getButtons();
+  if(trace_)
+    buttons = trace_->buttons(trace_index_, buttons);
   unsigned int new_buttons = buttons & ~reported_buttons_;
   reported_buttons_ = buttons;
   return new_buttons;
 }
+
+void ScifiDisplayBoard::set_trace(ScifiDisplayTrace* trace, int index) {
+  trace_ = trace;
+  trace_index_ = index;
+}
+
+long ScifiDisplayBoard::next_random() {
+  long value = random();
+  return (trace_ ? trace_->random(value) : value);
+}
+
+void ScifiDisplayBoard::setup_display(bool active, byte intensity) {
+  if(trace_)
+    trace_->setup_display(trace_index_, active, intensity);
+  board_.setupDisplay(active, intensity);
+}
+
+void ScifiDisplayBoard::clear_display() {
+  if(trace_)
+    trace_->clear_display(trace_index_);
+  board_.clearDisplay();
+}
+
+void ScifiDisplayBoard::set_display_to_string(const char* string) {
+  if(trace_)
+    trace_->set_display_to_string(trace_index_, string);
+  board_.setDisplayToString(string);
+}
+
+void ScifiDisplayBoard::set_leds(word leds) {
+  if(trace_)
+    trace_->set_leds(trace_index_, leds);
+  board_.setLEDs(leds);
+}
+
+void ScifiDisplayBoard::set_led(byte color, byte index) {
+  if(trace_)
+    trace_->set_led(trace_index_, color, index);
+  board_.setLED(color, index);
+}
@@ -21,6 +21,7 @@
 #define SCIFIDISPLAYBOARD_H
 
 #include <TM1638.h>
+#include <ScifiDisplayTrace.h>
 
 /**
  * An individual TM1638 display board.  We store 8 messages that can be flashed
@@ -106,12 +107,30 @@ class ScifiDisplayBoard {
      */
     unsigned int update(unsigned int current_millis);
 
+    /**
+     * Report this board's inputs and bus writes to trace (or stop, if NULL),
+     * as board number index.  Called by ScifiDisplayBase::set_trace().
+     */
+    void set_trace(ScifiDisplayTrace* trace, int index);
+
   private:
     void update_led(int index);
     unsigned int get_button_presses();
 
+    // Everything that reads from or writes to the outside world goes through
+    // these, so it can be traced.
+    long next_random();
+    void setup_display(bool active, byte intensity);
+    void clear_display();
+    void set_display_to_string(const char* string);
+    void set_leds(word leds);
+    void set_led(byte color, byte index);
+
     TM1638 board_;
 
+    ScifiDisplayTrace* trace_;
+    int trace_index_;
+
     unsigned int reported_buttons_;
 
     char messages_[NUM_DIGITS][NUM_DIGITS + 1];
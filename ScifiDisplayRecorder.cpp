@@ -0,0 +1,145 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ScifiDisplayRecorder.h"
+
+ScifiDisplayRecorder::ScifiDisplayRecorder(Print& out) : out_(out) {
+  last_millis_ = 0u;
+  update_pending_ = false;
+  skipped_ = 0ul;
+  for(int i = 0; i < ScifiDisplayBase::MAX_BOARDS; ++i)
+    buttons_[i] = 0;
+}
+
+void ScifiDisplayRecorder::start(int num_boards) {
+  const byte header[5] = { 'S', 'D', 'T', VERSION, (byte)num_boards };
+  out_.write(header, sizeof(header));
+  last_millis_ = 0u;
+  update_pending_ = false;
+  skipped_ = 0ul;
+  for(int i = 0; i < ScifiDisplayBase::MAX_BOARDS; ++i)
+    buttons_[i] = 0;
+}
+
+void ScifiDisplayRecorder::command(unsigned int current_millis, const char* command) {
+  if(update_pending_) {
+    update_pending_ = false;
+    skip(update_millis_);
+  }
+  call(COMMAND, current_millis);
+  text(command);
+}
+
+void ScifiDisplayRecorder::update(unsigned int current_millis) {
+  // Don't write anything until we know the update does something.
+  if(update_pending_)
+    skip(update_millis_);
+  update_millis_ = current_millis;
+  update_pending_ = true;
+
+  if(current_millis - last_millis_ >= MAX_DELTA) {
+    update_pending_ = false;
+    call(UPDATE, current_millis);
+  }
+}
+
+long ScifiDisplayRecorder::random(long value) {
+  tag(RANDOM, 0);
+  number((unsigned long)value);
+  return value;
+}
+
+unsigned int ScifiDisplayRecorder::buttons(int board, unsigned int value) {
+  if((byte)value != buttons_[board]) {
+    buttons_[board] = (byte)value;
+    tag(BUTTONS, board);
+    number(value);
+  }
+  return value;
+}
+
+void ScifiDisplayRecorder::setup_display(int board, bool active, int intensity) {
+  tag(SETUP_DISPLAY, board);
+  out_.write((byte)active);
+  out_.write((byte)intensity);
+}
+
+void ScifiDisplayRecorder::clear_display(int board) {
+  tag(CLEAR_DISPLAY, board);
+}
+
+void ScifiDisplayRecorder::set_display_to_string(int board, const char* string) {
+  tag(SET_DISPLAY_TO_STRING, board);
+  text(string);
+}
+
+void ScifiDisplayRecorder::set_leds(int board, unsigned int leds) {
+  tag(SET_LEDS, board);
+  number(leds);
+}
+
+void ScifiDisplayRecorder::set_led(int board, int color, int index) {
+  tag(SET_LED, board);
+  out_.write((byte)color);
+  out_.write((byte)index);
+}
+
+void ScifiDisplayRecorder::tag(int type, int board) {
+  if(update_pending_) {
+    update_pending_ = false;
+    call(UPDATE, update_millis_);
+  }
+  out_.write((byte)(type | (board << 4)));
+}
+
+void ScifiDisplayRecorder::skip(unsigned int current_millis) {
+  if(skipped_ == 0ul)
+    skipped_first_millis_ = current_millis;
+  skipped_last_millis_ = current_millis;
+  ++skipped_;
+}
+
+void ScifiDisplayRecorder::call(int type, unsigned int current_millis) {
+  out_.write((byte)type);
+  number(current_millis - last_millis_);
+  number(skipped_);
+  if(skipped_ > 0ul) {
+    number(skipped_first_millis_ - last_millis_);
+    number(current_millis - skipped_last_millis_);
+  }
+  skipped_ = 0ul;
+  last_millis_ = current_millis;
+}
+
+void ScifiDisplayRecorder::number(unsigned long value) {
+  while(value >= 0x80) {
+    out_.write((byte)(value | 0x80));
+    value >>= 7;
+  }
+  out_.write((byte)value);
+}
+
+void ScifiDisplayRecorder::text(const char* string) {
+  int len;
+  for(len = 0; string[len]; ++len)
+    ;
+  number((unsigned long)len);
+  out_.write((const byte*)string, (size_t)len);
+}
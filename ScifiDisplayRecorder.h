@@ -0,0 +1,110 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCIFIDISPLAYRECORDER_H
+#define SCIFIDISPLAYRECORDER_H
+
+#include <Arduino.h>
+#include <ScifiDisplay.h>
+
+/**
+ * A ScifiDisplayTrace that writes a compact binary trace to a Print, e.g. a
+ * spare hardware serial port or an SD card file.  Replay it on the host with
+ * host/scifidisplay-replay.
+ *
+ * The trace starts with the bytes 'S' 'D' 'T', the format VERSION, and the
+ * number of boards.  Each record after that is a tag byte, whose low nibble is
+ * the record type and high nibble the board, followed by the type's fields.
+ * Numbers are unsigned LEB128 varints; millis are deltas from the previous
+ * UPDATE or COMMAND record.  Buttons are only recorded when they change.
+ *
+ * Updates that read nothing but unchanged buttons and write nothing don't get
+ * records of their own.  Instead, each UPDATE or COMMAND record counts the
+ * ones skipped since the previous record, and if there were any, gives the
+ * millis of the first (as a delta from the previous record) and the last (as
+ * a delta back from this one).  The replayer spreads them evenly between those
+ * two, which keeps the real update() cadence and gives a different library
+ * version the chance to act in between.  An update MAX_DELTA or more millis
+ * after the previous record gets a record anyway, so deltas fit in an AVR's
+ * 16-bit unsigned int.  Updates skipped after the last record are lost when
+ * recording stops.
+ *
+ * A replay starts from freshly constructed boards, so attach the recorder in
+ * setup() before running any commands.
+ */
+class ScifiDisplayRecorder : public ScifiDisplayTrace {
+  public:
+    /// Version of the trace format.
+    static const byte VERSION = 2;
+
+    /// Record types, and their fields.
+    enum {
+      UPDATE = 0,                // millis, skipped[, first, last]
+      COMMAND = 1,               // millis, skipped[, first, last], length, text
+      RANDOM = 2,                // value
+      BUTTONS = 3,               // value
+      SETUP_DISPLAY = 4,         // active byte, intensity byte
+      CLEAR_DISPLAY = 5,         //
+      SET_DISPLAY_TO_STRING = 6, // length, text
+      SET_LEDS = 7,              // leds
+      SET_LED = 8,               // color byte, index byte
+    };
+
+    /**
+     * Record to out, once attached with ScifiDisplayBase::set_trace().
+     */
+    explicit ScifiDisplayRecorder(Print& out);
+
+    virtual void start(int num_boards);
+    virtual void command(unsigned int current_millis, const char* command);
+    virtual void update(unsigned int current_millis);
+    virtual long random(long value);
+    virtual unsigned int buttons(int board, unsigned int value);
+    virtual void setup_display(int board, bool active, int intensity);
+    virtual void clear_display(int board);
+    virtual void set_display_to_string(int board, const char* string);
+    virtual void set_leds(int board, unsigned int leds);
+    virtual void set_led(int board, int color, int index);
+
+  private:
+    /**
+     * Longest time to go without a record.  Deltas are worked out in unsigned
+     * int, which is only 16 bits on AVR, so they have to stay well short of
+     * wrapping around.
+     */
+    static const unsigned int MAX_DELTA = 0x8000u;
+
+    void skip(unsigned int current_millis);
+    void call(int type, unsigned int current_millis);
+    void tag(int type, int board);
+    void number(unsigned long value);
+    void text(const char* string);
+
+    Print& out_;
+
+    unsigned int last_millis_;
+    unsigned int update_millis_;
+    bool update_pending_;
+    unsigned long skipped_;
+    unsigned int skipped_first_millis_;
+    unsigned int skipped_last_millis_;
+    byte buttons_[ScifiDisplayBase::MAX_BOARDS];
+};
+
+#endif
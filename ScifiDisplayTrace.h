@@ -0,0 +1,75 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCIFIDISPLAYTRACE_H
+#define SCIFIDISPLAYTRACE_H
+
+/**
+ * Hooks for watching everything a ScifiDisplay does: the calls made into it,
+ * the inputs it reads (random() and the buttons), and the writes it makes to
+ * the TM1638 bus.  That's everything its behavior depends on, so it's enough
+ * to replay a session exactly.  Attach one with ScifiDisplayBase::set_trace().
+ * See ScifiDisplayRecorder for one that records a trace.
+ */
+class ScifiDisplayTrace {
+  public:
+    /**
+     * Called when the trace is attached to a ScifiDisplay of num_boards
+     * boards.
+     */
+    virtual void start(int num_boards) = 0;
+
+    /**
+     * Called on entering ScifiDisplayBase::process_command().
+     */
+    virtual void command(unsigned int current_millis, const char* command) = 0;
+
+    /**
+     * Called on entering ScifiDisplayBase::update().
+     */
+    virtual void update(unsigned int current_millis) = 0;
+
+    /**
+     * Called with each value returned by random().  Return the value the
+     * board should use, normally value itself.
+     */
+    virtual long random(long value) = 0;
+
+    /**
+     * Called with each value returned by board's TM1638::getButtons().  Return
+     * the value the board should use, normally value itself.
+     */
+    virtual unsigned int buttons(int board, unsigned int value) = 0;
+
+    /**
+     * Called before each write to board's TM1638; the arguments are those of
+     * the TM1638 method of the same name.
+     */
+    virtual void setup_display(int board, bool active, int intensity) = 0;
+    virtual void clear_display(int board) = 0;
+    virtual void set_display_to_string(int board, const char* string) = 0;
+    virtual void set_leds(int board, unsigned int leds) = 0;
+    virtual void set_led(int board, int color, int index) = 0;
+
+  protected:
+    ~ScifiDisplayTrace() {
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <ScifiDisplay.h>
+#include <ScifiDisplayRecorder.h>
+// Even though this library is never referenced directly here, it's used by
+// ScifiDisplay, and the Arduino IDE isn't smart enough to add the required
+// include directory.  Short version: any top level file that uses ScifiDisplay
+// also has to include this file.
+#include <TM1638.h>
+
+// Firmware for boards driven by host/scifidisplayd instead of a person at the
+// serial monitor.  Each line received is "ID COMMAND", and each reply is
+// "ID + RESPONSE" on success or "ID - RESPONSE" on failure, all on one line.
+// The daemon matches replies to commands by ID, so it can keep several
+// commands in flight without waiting for each reply.
+//
+// There are no canned messages here: the daemon sets them with "m s" commands.
+
+static const int NUM_BOARDS = 4;
+
+// All four boards share data pin 8 and clock pin 7, and have strobe pins 6, 5,
+// 4, and 3.
+ScifiDisplay<NUM_BOARDS> display(8, 7, 6, 5, 4, 3);
+
+// Uncomment to record a trace of everything the display does to a second
+// serial port (on boards that have one), for host/scifidisplay-replay.
+//#define TRACE_PORT Serial1
+
+#ifdef TRACE_PORT
+ScifiDisplayRecorder recorder(TRACE_PORT);
+#endif
+
+// Room for an ID of up to 4 digits and a space before the command.
+static const int LINE_SIZE = 5 + ScifiDisplayBase::MAX_COMMAND_SIZE;
+
+static char line[LINE_SIZE];
+static int line_len = 0;
+static bool line_overflow = false;
+
+static void run_line(char* line, unsigned int current_millis) {
+  char* command = line;
+  while(*command && *command != ' ')
+    ++command;
+  if(*command)
+    *command++ = '\0';
+  while(*command == ' ')
+    ++command;
+
+  char response[ScifiDisplayBase::RESPONSE_SIZE];
+  bool ok;
+  if(line_overflow) {
+    snprintf(response, sizeof(response), "Command too long");
+    ok = false;
+  }
+  else
+    ok = display.process_command(command, response, current_millis);
+
+  // Squash multi-line responses (like info's) onto one line.
+  int len = 0;
+  for(; response[len]; ++len) {
+    if(response[len] == '\n')
+      response[len] = ' ';
+  }
+  while(len > 0 && response[len - 1] == ' ')
+    response[--len] = '\0';
+
+  Serial.print(line);
+  Serial.print(ok ? " + " : " - ");
+  Serial.println(response);
+}
+
+void setup() {
+  // The daemon defaults to this speed too.
+  Serial.begin(115200);
+
+#ifdef TRACE_PORT
+  TRACE_PORT.begin(115200);
+  display.set_trace(&recorder);
+#endif
+}
+
+void loop() {
+  unsigned int current_millis = millis();
+
+  // Read without blocking so update() keeps the panels flashing on time.
+  while(Serial.available() > 0) {
+    char c = (char)Serial.read();
+    if(c == '\r')
+      continue;
+    if(c != '\n') {
+      if(line_len < LINE_SIZE - 1)
+        line[line_len++] = c;
+      else
+        line_overflow = true;
+      continue;
+    }
+
+    line[line_len] = '\0';
+    if(line_len > 0)
+      run_line(line, current_millis);
+    line_len = 0;
+    line_overflow = false;
+  }
+
+  display.update(current_millis);
+}
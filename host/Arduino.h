@@ -0,0 +1,48 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Just enough of the Arduino core to build ScifiDisplay on the host, for the
+// tools in this directory.  Put this directory on the include path before
+// building ScifiDisplay*.cpp.
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+/// Arduino's base class for byte sinks like Serial.
+class Print {
+  public:
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while(size-- > 0)
+        n += write(*buffer++);
+      return n;
+    }
+};
+
+#endif
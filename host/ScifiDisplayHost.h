@@ -0,0 +1,61 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Pieces shared by the host tools in this directory.
+
+#ifndef SCIFIDISPLAYHOST_H
+#define SCIFIDISPLAYHOST_H
+
+#include "Arduino.h"
+#include "ScifiDisplay.h"
+
+/// A Print that writes to a stdio FILE.
+class FilePrint : public Print {
+  public:
+    explicit FilePrint(FILE* file) : file_(file) {
+    }
+
+    virtual size_t write(uint8_t c) {
+      return (fputc(c, file_) == EOF ? 0 : 1);
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      return fwrite(buffer, 1, size, file_);
+    }
+
+  private:
+    FILE* file_;
+};
+
+/**
+ * Return a new ScifiDisplay<> of num_boards boards, or NULL if num_boards isn't
+ * in the range [1,MAX_BOARDS].  The pins mean nothing to the host TM1638, but
+ * they're kept distinct.
+ */
+inline ScifiDisplayBase* make_display(int num_boards) {
+  switch(num_boards) {
+    case 1: return new ScifiDisplay<1>(8, 7, 6);
+    case 2: return new ScifiDisplay<2>(8, 7, 6, 5);
+    case 3: return new ScifiDisplay<3>(8, 7, 6, 5, 4);
+    case 4: return new ScifiDisplay<4>(8, 7, 6, 5, 4, 3);
+  }
+  return 0;
+}
+
+#endif
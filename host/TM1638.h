@@ -0,0 +1,56 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A stand-in for the TM1638 library on the host.  It has the same interface
+// as the parts of TM1638 that ScifiDisplayBoard uses, but there is no board at
+// the other end: writes go nowhere and no buttons are ever pressed.
+
+#ifndef TM1638_h
+#define TM1638_h
+
+#include "Arduino.h"
+
+class TM1638 {
+  public:
+    TM1638(byte data_pin, byte clock_pin, byte strobe_pin,
+        boolean activate_display = true, byte intensity = 7) {
+    }
+
+    void setupDisplay(boolean active, byte intensity) {
+    }
+
+    void clearDisplay() {
+    }
+
+    void setDisplayToString(const char* string, const word dots = 0,
+        const byte pos = 0) {
+    }
+
+    void setLEDs(word leds) {
+    }
+
+    void setLED(byte color, byte pos) {
+    }
+
+    byte getButtons() {
+      return 0;
+    }
+};
+
+#endif
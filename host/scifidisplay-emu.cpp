@@ -0,0 +1,231 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  scifidisplay-emu - a ScifiDisplay controller on a pseudo-terminal
+
+  Runs the host-built library behind a pty that speaks the same line protocol
+  as examples/scifi_display_daemon, so scifidisplayd (or anything else) can be
+  tested without hardware.  Build from the top of the source tree with:
+
+    g++ -std=c++11 -Wall -I. -Ihost -o scifidisplay-emu \
+        host/scifidisplay-emu.cpp ScifiDisplay.cpp ScifiDisplayBoard.cpp \
+        ScifiDisplayRecorder.cpp
+
+  Usage: scifidisplay-emu [-v] [-n BOARDS] [-l LINK] [-r TRACE]
+
+  Prints the pty's path on stdout; -l also symlinks LINK to it, which gives the
+  daemon a stable name to reopen if the emulator is restarted.  -r records a
+  trace of the session to TRACE, for scifidisplay-replay.  -v prints each line
+  received on stderr, in the order it's run.
+*/
+
+#include "Arduino.h"
+#include "ScifiDisplay.h"
+#include "ScifiDisplayRecorder.h"
+#include "ScifiDisplayHost.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Same as the example sketch: an ID of up to 4 digits, a space, the command.
+static const int LINE_SIZE = 5 + ScifiDisplayBase::MAX_COMMAND_SIZE;
+
+static volatile sig_atomic_t quit = 0;
+
+static void on_signal(int) {
+  quit = 1;
+}
+
+static unsigned int millis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned int)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
+}
+
+static void write_all(int fd, const char* data, size_t len) {
+  while(len > 0) {
+    ssize_t n = write(fd, data, len);
+    if(n < 0) {
+      if(errno == EINTR)
+        continue;
+      if(errno == EAGAIN) {
+        struct pollfd p = { fd, POLLOUT, 0 };
+        poll(&p, 1, 100);
+        continue;
+      }
+      return;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+}
+
+static void run_line(ScifiDisplayBase* display, int fd, char* line,
+    bool overflow, unsigned int current_millis) {
+  char* command = line;
+  while(*command && *command != ' ')
+    ++command;
+  if(*command)
+    *command++ = '\0';
+  while(*command == ' ')
+    ++command;
+
+  char response[ScifiDisplayBase::RESPONSE_SIZE];
+  bool ok;
+  if(overflow) {
+    snprintf(response, sizeof(response), "Command too long");
+    ok = false;
+  }
+  else
+    ok = display->process_command(command, response, current_millis);
+
+  int len = 0;
+  for(; response[len]; ++len) {
+    if(response[len] == '\n')
+      response[len] = ' ';
+  }
+  while(len > 0 && response[len - 1] == ' ')
+    response[--len] = '\0';
+
+  char reply[LINE_SIZE + ScifiDisplayBase::RESPONSE_SIZE + 8];
+  int reply_len = snprintf(reply, sizeof(reply), "%s %c %s\r\n", line,
+      (ok ? '+' : '-'), response);
+  write_all(fd, reply, (size_t)reply_len);
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr, "Usage: %s [-v] [-n BOARDS] [-l LINK] [-r TRACE]\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  int num_boards = ScifiDisplayBase::MAX_BOARDS;
+  const char* link_path = 0;
+  const char* trace_path = 0;
+  bool verbose = false;
+
+  int opt;
+  while((opt = getopt(argc, argv, "vn:l:r:")) != -1) {
+    switch(opt) {
+      case 'v': verbose = true; break;
+      case 'n': num_boards = atoi(optarg); break;
+      case 'l': link_path = optarg; break;
+      case 'r': trace_path = optarg; break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind != argc || num_boards < 1 || num_boards > ScifiDisplayBase::MAX_BOARDS)
+    usage(argv[0]);
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    perror("posix_openpt");
+    return 1;
+  }
+  const char* slave_path = ptsname(master);
+
+  // Hold the slave open ourselves so the master doesn't see a hangup every time
+  // a client closes it, and make it raw so nothing is echoed or translated.
+  int slave = open(slave_path, O_RDWR | O_NOCTTY);
+  struct termios t;
+  if(slave < 0 || tcgetattr(slave, &t) < 0) {
+    perror(slave_path);
+    return 1;
+  }
+  cfmakeraw(&t);
+  tcsetattr(slave, TCSANOW, &t);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if(link_path) {
+    unlink(link_path);
+    if(symlink(slave_path, link_path) < 0) {
+      perror(link_path);
+      return 1;
+    }
+  }
+  printf("%s\n", slave_path);
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  ScifiDisplayBase* display = make_display(num_boards);
+
+  FILE* trace = 0;
+  if(trace_path && !(trace = fopen(trace_path, "wb"))) {
+    perror(trace_path);
+    return 1;
+  }
+  FilePrint trace_print(trace);
+  ScifiDisplayRecorder recorder(trace_print);
+  if(trace)
+    display->set_trace(&recorder);
+
+  char line[LINE_SIZE];
+  int line_len = 0;
+  bool line_overflow = false;
+
+  while(!quit) {
+    // Wake at least every millisecond, like a busy Arduino loop().
+    struct pollfd p = { master, POLLIN, 0 };
+    poll(&p, 1, 1);
+
+    unsigned int current_millis = millis();
+
+    char buf[256];
+    ssize_t n;
+    while((n = read(master, buf, sizeof(buf))) > 0) {
+      for(ssize_t i = 0; i < n; ++i) {
+        char c = buf[i];
+        if(c == '\r')
+          continue;
+        if(c != '\n') {
+          if(line_len < LINE_SIZE - 1)
+            line[line_len++] = c;
+          else
+            line_overflow = true;
+          continue;
+        }
+
+        line[line_len] = '\0';
+        if(verbose && line_len > 0)
+          fprintf(stderr, "%s\n", line);
+        if(line_len > 0)
+          run_line(display, master, line, line_overflow, current_millis);
+        line_len = 0;
+        line_overflow = false;
+      }
+    }
+
+    display->update(current_millis);
+  }
+
+  if(trace)
+    fclose(trace);
+  if(link_path)
+    unlink(link_path);
+  return 0;
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+#                <https://github.com/chazomaticus/scifidisplay>
+# Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+#
+# ScifiDisplay is free software: you can redistribute it and/or modify it under
+# the terms of the GNU Lesser General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+
+# Checks for ScifiDisplayRecorder and scifidisplay-replay, on a short session
+# recorded with scifidisplay-emu -r:
+#
+# * The trace replays with no differences.
+# * A trace with one write changed fails, showing the recorded and replayed
+#   writes.
+# * A trace cut off partway through a record replays as far as it goes, with a
+#   warning.
+#
+# Run from anywhere; exits nonzero on failure.
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+TOP = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Record types from ScifiDisplayRecorder.h.
+SET_DISPLAY_TO_STRING = 6
+
+
+def build(tmp):
+    emu = os.path.join(tmp, 'scifidisplay-emu')
+    replay = os.path.join(tmp, 'scifidisplay-replay')
+    sources = ['ScifiDisplay.cpp', 'ScifiDisplayBoard.cpp',
+               'ScifiDisplayRecorder.cpp']
+    subprocess.check_call(
+        ['g++', '-std=c++11', '-Wall', '-I.', '-Ihost', '-o', emu,
+         'host/scifidisplay-emu.cpp'] + sources, cwd=TOP)
+    subprocess.check_call(
+        ['g++', '-std=c++11', '-Wall', '-I.', '-Ihost', '-o', replay,
+         'host/scifidisplay-replay.cpp'] + sources, cwd=TOP)
+    return emu, replay
+
+
+def wait_for(path):
+    for _ in range(100):
+        if os.path.exists(path):
+            return
+        time.sleep(0.05)
+    raise RuntimeError('%s never appeared' % path)
+
+
+def record(emu, tmp):
+    """Run a short session through the emulator and return its trace."""
+    link = os.path.join(tmp, 'emu')
+    trace = os.path.join(tmp, 'session.sdt')
+    proc = subprocess.Popen([emu, '-n', '2', '-l', link, '-r', trace],
+                            stdout=subprocess.DEVNULL)
+    try:
+        wait_for(link)
+        fd = os.open(link, os.O_RDWR | os.O_NOCTTY)
+        for i, command in enumerate(['l b 1 r', 'm s 2 8 run away', 'm f 2 8',
+                                     'l f a g', 'b 1 3', 'm d 2']):
+            os.write(fd, ('%d %s\n' % (i + 1, command)).encode())
+            time.sleep(0.2)
+        os.close(fd)
+    finally:
+        proc.terminate()
+        proc.wait()
+    with open(trace, 'rb') as f:
+        return f.read()
+
+
+def replay(binary, tmp, name, data):
+    path = os.path.join(tmp, name)
+    with open(path, 'wb') as f:
+        f.write(data)
+    proc = subprocess.run([binary, path], stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE, universal_newlines=True)
+    return proc.returncode, proc.stdout, proc.stderr
+
+
+def find_message(data, message):
+    """Return the offset of the first SET_DISPLAY_TO_STRING record of message."""
+    record = bytes([len(message)]) + message.encode()
+    start = data.find(record)
+    while start > 0 and data[start - 1] & 0xf != SET_DISPLAY_TO_STRING:
+        start = data.find(record, start + 1)
+    if start <= 0:
+        raise RuntimeError('no setDisplayToString("%s") in the trace' % message)
+    return start - 1
+
+
+def main():
+    errors = []
+    with tempfile.TemporaryDirectory() as tmp:
+        emu, replay_bin = build(tmp)
+        trace = record(emu, tmp)
+
+        status, out, err = replay(replay_bin, tmp, 'same.sdt', trace)
+        if status != 0 or '\n0 ticks differ\n' not in '\n' + out:
+            errors.append('unchanged trace exited %d:\n%s%s' % (status, out, err))
+
+        # Record the first flash of the message as "Run away" instead.
+        offset = find_message(trace, 'run away')
+        changed = bytearray(trace)
+        changed[offset + 2] = ord('R')
+        status, out, err = replay(replay_bin, tmp, 'changed.sdt', bytes(changed))
+        lines = out.splitlines()
+        if (status != 1 or '  - 2 setDisplayToString("Run away")' not in lines
+                or '  + 2 setDisplayToString("run away")' not in lines):
+            errors.append('changed trace exited %d:\n%s%s' % (status, out, err))
+
+        # Cut off partway through that record.
+        status, out, err = replay(replay_bin, tmp, 'cut.sdt', trace[:offset + 4])
+        if (status != 0 or '\n0 ticks differ\n' not in '\n' + out
+                or 'warning' not in err):
+            errors.append('cut trace exited %d:\n%s%s' % (status, out, err))
+
+    for error in errors:
+        print(error)
+    print('FAIL' if errors else 'ok')
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
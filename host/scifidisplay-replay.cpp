@@ -0,0 +1,604 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  scifidisplay-replay - replay a ScifiDisplayRecorder trace against the library
+
+  Feeds the commands, updates, random() values and button states from a trace
+  back into the library as built on the host, and checks that it makes the
+  same TM1638 bus writes as were recorded.  Any difference is printed and the
+  exit status is 1, so a trace of a glitch makes a regression test.  Build
+  from the top of the source tree with:
+
+    g++ -std=c++11 -O2 -Wall -I. -Ihost -o scifidisplay-replay \
+        host/scifidisplay-replay.cpp ScifiDisplay.cpp ScifiDisplayBoard.cpp \
+        ScifiDisplayRecorder.cpp
+
+  Usage: scifidisplay-replay [-v] [-o OUT] TRACE
+
+  Updates the recorder skipped because they did nothing are re-issued too,
+  spread evenly over the span it recorded for them, so a library version that
+  acts at a different time still gets the chance.
+
+  A trace captured off a serial port can stop anywhere, so any bytes after the
+  last complete record are ignored with a warning, and the last tick only has
+  to start out the way it was recorded.
+
+  -v prints a line per recorded tick (and per skipped update that now does
+  something): millis, time since the previous update, estimated bus bytes
+  recorded and replayed, and host time spent in the library.  -o records the
+  replay to OUT, which is how to refresh a trace after an intentional change
+  in behavior.  The summary at the end gives the real update interval and the
+  total estimated bus bytes, for comparing bus load between library versions
+  on the same trace.
+*/
+
+#include "Arduino.h"
+#include "ScifiDisplay.h"
+#include "ScifiDisplayRecorder.h"
+#include "ScifiDisplayHost.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef ScifiDisplayRecorder R;
+
+struct Event {
+  int type;
+  int board;
+  unsigned long value; // millis for UPDATE and COMMAND
+  int a;
+  int b;
+  std::string text;
+
+  bool operator==(const Event& o) const {
+    return (type == o.type && board == o.board && value == o.value && a == o.a
+        && b == o.b && text == o.text);
+  }
+  bool operator!=(const Event& o) const {
+    return !(*this == o);
+  }
+};
+
+/**
+ * An UPDATE or COMMAND and everything that happened during it.  Updates the
+ * recorder skipped are ticks too, but not recorded ones, and have nothing
+ * happen during them.
+ */
+struct Tick {
+  Event call;
+  bool recorded;
+  std::vector<Event> inputs;
+  std::vector<Event> writes;
+};
+
+static std::string describe(const Event& e) {
+  char buf[128];
+  switch(e.type) {
+    case R::SETUP_DISPLAY:
+      snprintf(buf, sizeof(buf), "%d setupDisplay(%d, %d)", e.board + 1, e.a, e.b);
+      break;
+    case R::CLEAR_DISPLAY:
+      snprintf(buf, sizeof(buf), "%d clearDisplay()", e.board + 1);
+      break;
+    case R::SET_DISPLAY_TO_STRING:
+      snprintf(buf, sizeof(buf), "%d setDisplayToString(\"%s\")", e.board + 1,
+          e.text.c_str());
+      break;
+    case R::SET_LEDS:
+      snprintf(buf, sizeof(buf), "%d setLEDs(0x%04lx)", e.board + 1, e.value);
+      break;
+    case R::SET_LED:
+      snprintf(buf, sizeof(buf), "%d setLED(%d, %d)", e.board + 1, e.a, e.b);
+      break;
+    default:
+      snprintf(buf, sizeof(buf), "record type %d", e.type);
+  }
+  return buf;
+}
+
+/**
+ * Roughly how many bytes each write clocks onto the bus.  The TM1638 library
+ * sends a command, an address and a data byte per digit or LED, and a lone
+ * command to set up the display.
+ */
+static unsigned long bus_bytes(const Event& e) {
+  switch(e.type) {
+    case R::SETUP_DISPLAY: return 1;
+    case R::SET_LED: return 3;
+    case R::CLEAR_DISPLAY:
+    case R::SET_DISPLAY_TO_STRING:
+    case R::SET_LEDS: return 3 * ScifiDisplayBoard::NUM_DIGITS;
+  }
+  return 0;
+}
+
+static unsigned long bus_bytes(const std::vector<Event>& events) {
+  unsigned long total = 0;
+  for(size_t i = 0; i < events.size(); ++i)
+    total += bus_bytes(events[i]);
+  return total;
+}
+
+class Reader {
+  public:
+    Reader(const std::vector<byte>& data) : data_(data), pos_(0) {
+    }
+
+    bool done() const {
+      return pos_ >= data_.size();
+    }
+
+    size_t pos() const {
+      return pos_;
+    }
+
+    bool read_byte(int* out) {
+      if(done())
+        return false;
+      *out = data_[pos_++];
+      return true;
+    }
+
+    bool read_number(unsigned long* out) {
+      unsigned long value = 0;
+      for(int shift = 0; shift < 64; shift += 7) {
+        int b;
+        if(!read_byte(&b))
+          return false;
+        value |= (unsigned long)(b & 0x7f) << shift;
+        if(!(b & 0x80)) {
+          *out = value;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool read_text(std::string* out) {
+      unsigned long len;
+      if(!read_number(&len) || len > data_.size() - pos_)
+        return false;
+      out->assign((const char*)&data_[pos_], len);
+      pos_ += len;
+      return true;
+    }
+
+  private:
+    const std::vector<byte>& data_;
+    size_t pos_;
+};
+
+/**
+ * Read the fields common to UPDATE and COMMAND records, adding ticks for the
+ * updates skipped before this one.  millis is the previous record's, and is
+ * advanced to this one's.
+ */
+static bool parse_call(Reader& in, unsigned long* millis, std::vector<Tick>* ticks) {
+  unsigned long delta;
+  unsigned long skipped;
+  if(!in.read_number(&delta) || !in.read_number(&skipped))
+    return false;
+
+  if(skipped > 0) {
+    unsigned long first;
+    unsigned long last;
+    if(!in.read_number(&first) || !in.read_number(&last) || first + last > delta)
+      return false;
+
+    unsigned long first_millis = *millis + first;
+    unsigned long span = delta - first - last;
+    for(unsigned long i = 0; i < skipped; ++i) {
+      Tick tick = Tick();
+      tick.call.type = R::UPDATE;
+      tick.call.value = first_millis + (skipped > 1 ? span * i / (skipped - 1) : 0);
+      tick.recorded = false;
+      ticks->push_back(tick);
+    }
+  }
+
+  *millis += delta;
+  return true;
+}
+
+/**
+ * Parse a trace into ticks, returning false if the header isn't valid.
+ * Parsing stops at the first record that's cut off (or otherwise invalid),
+ * and *ignored is how many bytes that left unread.
+ */
+static bool parse(const std::vector<byte>& data, int* num_boards,
+    std::vector<Tick>* ticks, size_t* ignored) {
+  Reader in(data);
+  *ignored = 0;
+  int header[5];
+  for(int i = 0; i < 5; ++i) {
+    if(!in.read_byte(&header[i]))
+      return false;
+  }
+  if(header[0] != 'S' || header[1] != 'D' || header[2] != 'T'
+      || header[3] != R::VERSION || header[4] < 1
+      || header[4] > ScifiDisplayBase::MAX_BOARDS)
+    return false;
+  *num_boards = header[4];
+
+  unsigned long millis = 0;
+  while(!in.done()) {
+    size_t start = in.pos();
+    size_t num_ticks = ticks->size();
+    int tag;
+    in.read_byte(&tag);
+
+    Event e = Event();
+    e.type = tag & 0xf;
+    e.board = tag >> 4;
+
+    bool ok = (e.board < *num_boards);
+    switch(ok ? e.type : -1) {
+      case R::UPDATE:
+        ok = parse_call(in, &millis, ticks);
+        e.value = millis;
+        break;
+      case R::COMMAND:
+        ok = parse_call(in, &millis, ticks) && in.read_text(&e.text);
+        e.value = millis;
+        break;
+      case R::RANDOM:
+      case R::BUTTONS:
+      case R::SET_LEDS:
+        ok = in.read_number(&e.value);
+        break;
+      case R::SETUP_DISPLAY:
+      case R::SET_LED:
+        ok = in.read_byte(&e.a) && in.read_byte(&e.b);
+        break;
+      case R::CLEAR_DISPLAY:
+        break;
+      case R::SET_DISPLAY_TO_STRING:
+        ok = in.read_text(&e.text);
+        break;
+      default:
+        ok = false;
+    }
+    if(ok && e.type != R::UPDATE && e.type != R::COMMAND
+        && (ticks->empty() || !ticks->back().recorded))
+      ok = false;
+
+    if(!ok) {
+      ticks->resize(num_ticks);
+      *ignored = data.size() - start;
+      break;
+    }
+
+    if(e.type == R::UPDATE || e.type == R::COMMAND) {
+      ticks->push_back(Tick());
+      ticks->back().call = e;
+      ticks->back().recorded = true;
+    }
+    else if(e.type == R::RANDOM || e.type == R::BUTTONS)
+      ticks->back().inputs.push_back(e);
+    else
+      ticks->back().writes.push_back(e);
+  }
+  return true;
+}
+
+/**
+ * Plays back one tick's recorded inputs to the library and collects its bus
+ * writes.  Optionally passes everything on to a recorder too.
+ */
+class Player : public ScifiDisplayTrace {
+  public:
+    Player(ScifiDisplayTrace* recorder) : recorder_(recorder), tick_(0) {
+      memset(buttons_, 0, sizeof(buttons_));
+    }
+
+    void begin(const Tick* tick) {
+      tick_ = tick;
+      next_random_ = 0;
+      extra_randoms_ = 0;
+      writes_.clear();
+    }
+
+    /**
+     * Return the number of random() calls that didn't match up.  If the tick
+     * was cut off, calls past the end of the recording don't count.
+     */
+    int random_mismatches(bool cut_off) const {
+      int unused = 0;
+      for(size_t i = next_random_; i < tick_->inputs.size(); ++i)
+        unused += (tick_->inputs[i].type == R::RANDOM);
+      return (cut_off ? 0 : extra_randoms_) + unused;
+    }
+
+    const std::vector<Event>& writes() const {
+      return writes_;
+    }
+
+    virtual void start(int num_boards) {
+      if(recorder_)
+        recorder_->start(num_boards);
+    }
+
+    virtual void command(unsigned int current_millis, const char* command) {
+      if(recorder_)
+        recorder_->command(current_millis, command);
+    }
+
+    virtual void update(unsigned int current_millis) {
+      if(recorder_)
+        recorder_->update(current_millis);
+    }
+
+    virtual long random(long value) {
+      while(next_random_ < tick_->inputs.size()
+          && tick_->inputs[next_random_].type != R::RANDOM)
+        ++next_random_;
+      if(next_random_ < tick_->inputs.size())
+        value = (long)tick_->inputs[next_random_++].value;
+      else
+        ++extra_randoms_;
+      return (recorder_ ? recorder_->random(value) : value);
+    }
+
+    virtual unsigned int buttons(int board, unsigned int value) {
+      // Each board is read once per update, so any change recorded for it in
+      // this tick applies now.
+      for(size_t i = 0; i < tick_->inputs.size(); ++i) {
+        const Event& e = tick_->inputs[i];
+        if(e.type == R::BUTTONS && e.board == board)
+          buttons_[board] = (unsigned int)e.value;
+      }
+      value = buttons_[board];
+      return (recorder_ ? recorder_->buttons(board, value) : value);
+    }
+
+    virtual void setup_display(int board, bool active, int intensity) {
+      Event e = Event();
+      e.type = R::SETUP_DISPLAY;
+      e.board = board;
+      e.a = active;
+      e.b = (byte)intensity;
+      writes_.push_back(e);
+      if(recorder_)
+        recorder_->setup_display(board, active, intensity);
+    }
+
+    virtual void clear_display(int board) {
+      Event e = Event();
+      e.type = R::CLEAR_DISPLAY;
+      e.board = board;
+      writes_.push_back(e);
+      if(recorder_)
+        recorder_->clear_display(board);
+    }
+
+    virtual void set_display_to_string(int board, const char* string) {
+      Event e = Event();
+      e.type = R::SET_DISPLAY_TO_STRING;
+      e.board = board;
+      e.text = string;
+      writes_.push_back(e);
+      if(recorder_)
+        recorder_->set_display_to_string(board, string);
+    }
+
+    virtual void set_leds(int board, unsigned int leds) {
+      Event e = Event();
+      e.type = R::SET_LEDS;
+      e.board = board;
+      e.value = leds;
+      writes_.push_back(e);
+      if(recorder_)
+        recorder_->set_leds(board, leds);
+    }
+
+    virtual void set_led(int board, int color, int index) {
+      Event e = Event();
+      e.type = R::SET_LED;
+      e.board = board;
+      e.a = (byte)color;
+      e.b = (byte)index;
+      writes_.push_back(e);
+      if(recorder_)
+        recorder_->set_led(board, color, index);
+    }
+
+  private:
+    ScifiDisplayTrace* recorder_;
+    const Tick* tick_;
+    size_t next_random_;
+    int extra_randoms_;
+    unsigned int buttons_[ScifiDisplayBase::MAX_BOARDS];
+    std::vector<Event> writes_;
+};
+
+static double now_micros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr, "Usage: %s [-v] [-o OUT] TRACE\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  bool verbose = false;
+  const char* out_path = 0;
+
+  int opt;
+  while((opt = getopt(argc, argv, "vo:")) != -1) {
+    switch(opt) {
+      case 'v': verbose = true; break;
+      case 'o': out_path = optarg; break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind + 1 != argc)
+    usage(argv[0]);
+  const char* path = argv[optind];
+
+  FILE* file = fopen(path, "rb");
+  if(!file) {
+    perror(path);
+    return 2;
+  }
+  std::vector<byte> data;
+  byte buf[4096];
+  size_t n;
+  while((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    data.insert(data.end(), buf, buf + n);
+  fclose(file);
+
+  int num_boards;
+  std::vector<Tick> ticks;
+  size_t ignored;
+  if(!parse(data, &num_boards, &ticks, &ignored)) {
+    fprintf(stderr, "%s: not a valid version %d trace\n", path, R::VERSION);
+    return 2;
+  }
+  if(ignored > 0) {
+    fprintf(stderr, "%s: warning: ignoring the last %zu bytes, which aren't a"
+        " complete record\n", path, ignored);
+  }
+
+  FILE* out = 0;
+  if(out_path && !(out = fopen(out_path, "wb"))) {
+    perror(out_path);
+    return 2;
+  }
+  FilePrint out_print(out);
+  ScifiDisplayRecorder recorder(out_print);
+
+  Player player(out ? &recorder : 0);
+  ScifiDisplayBase* display = make_display(num_boards);
+  display->set_trace(&player);
+
+  unsigned long updates = 0;
+  unsigned long recorded_updates = 0;
+  unsigned long commands = 0;
+  unsigned long mismatches = 0;
+  unsigned long recorded_bytes = 0;
+  unsigned long replayed_bytes = 0;
+  unsigned long first_update = 0;
+  unsigned long last_update = 0;
+  unsigned long min_interval = (unsigned long)-1;
+  unsigned long max_interval = 0;
+  double total_micros = 0;
+  double max_micros = 0;
+
+  if(verbose)
+    printf("%10s %8s %8s %8s %8s\n", "millis", "interval", "recorded", "replayed", "host us");
+
+  for(size_t t = 0; t < ticks.size(); ++t) {
+    const Tick& tick = ticks[t];
+    player.begin(&tick);
+
+    double start = now_micros();
+    if(tick.call.type == R::COMMAND) {
+      char response[ScifiDisplayBase::RESPONSE_SIZE];
+      display->process_command(tick.call.text.c_str(), response,
+          (unsigned int)tick.call.value);
+      ++commands;
+    }
+    else
+      display->update((unsigned int)tick.call.value);
+    double micros = now_micros() - start;
+    total_micros += micros;
+    if(micros > max_micros)
+      max_micros = micros;
+
+    // The interval is the time since the last update(), i.e. how late this
+    // one could be in noticing anything.
+    unsigned long interval = (updates > 0 ? tick.call.value - last_update : 0);
+    if(tick.call.type == R::UPDATE) {
+      if(updates == 0)
+        first_update = tick.call.value;
+      else {
+        if(interval < min_interval)
+          min_interval = interval;
+        if(interval > max_interval)
+          max_interval = interval;
+      }
+      last_update = tick.call.value;
+      ++updates;
+      recorded_updates += tick.recorded;
+    }
+
+    const std::vector<Event>& writes = player.writes();
+    unsigned long recorded = bus_bytes(tick.writes);
+    unsigned long replayed = bus_bytes(writes);
+    recorded_bytes += recorded;
+    replayed_bytes += replayed;
+
+    // The recording may have stopped anywhere in the last tick, so it only
+    // has to match as far as it goes.
+    bool cut_off = (t + 1 == ticks.size());
+    int random_mismatches = player.random_mismatches(cut_off);
+    bool differs = (random_mismatches != 0 || (cut_off
+        ? (writes.size() < tick.writes.size()
+            || !std::equal(tick.writes.begin(), tick.writes.end(), writes.begin()))
+        : writes != tick.writes));
+    if(verbose && (tick.recorded || differs)) {
+      printf("%10lu %8lu %8lu %8lu %8.1f%s%s%s\n", tick.call.value, interval,
+          recorded, replayed, micros,
+          (tick.call.type == R::COMMAND ? " " : ""), tick.call.text.c_str(),
+          (tick.recorded ? "" : " (skipped)"));
+    }
+    if(!differs)
+      continue;
+
+    ++mismatches;
+    printf("tick %zu at %lu millis (%s%s) differs:\n", t, tick.call.value,
+        (tick.call.type == R::COMMAND ? "command " :
+            tick.recorded ? "update" : "skipped update"),
+        tick.call.text.c_str());
+    if(random_mismatches != 0)
+      printf("  %d random() calls don't match up\n", random_mismatches);
+    for(size_t i = 0; i < writes.size() || i < tick.writes.size(); ++i) {
+      if(i < writes.size() && i < tick.writes.size() && writes[i] == tick.writes[i])
+        continue;
+      if(i < tick.writes.size())
+        printf("  - %s\n", describe(tick.writes[i]).c_str());
+      if(i < writes.size())
+        printf("  + %s\n", describe(writes[i]).c_str());
+    }
+  }
+
+  printf("%lu updates (%lu recorded) and %lu commands over %lu millis\n",
+      updates, recorded_updates, commands,
+      (ticks.empty() ? 0 : ticks.back().call.value - ticks.front().call.value));
+  printf("update interval: %lu-%lu millis, %.2f mean\n",
+      (updates > 1 ? min_interval : 0), max_interval,
+      (updates > 1 ? (double)(last_update - first_update) / (updates - 1) : 0.0));
+  printf("bus bytes: %lu recorded, %lu replayed\n", recorded_bytes, replayed_bytes);
+  printf("host time: %.1f us/tick mean, %.1f us max\n",
+      (ticks.empty() ? 0 : total_micros / ticks.size()), max_micros);
+  printf("%lu ticks differ\n", mismatches);
+
+  if(out)
+    fclose(out);
+  return (mismatches == 0 ? 0 : 1);
+}
@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+#
+# ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+#                <https://github.com/chazomaticus/scifidisplay>
+# Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+#
+# ScifiDisplay is free software: you can redistribute it and/or modify it under
+# the terms of the GNU Lesser General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+
+# Checks for scifidisplayd:
+#
+# * Coalescing, against scifidisplay-emu: with the window full, a burst of
+#   commands must reach the controller in an order that leaves it in the state
+#   the client asked for, and every command must be answered.
+# * Half-closing, against scifidisplay-emu: a client that shuts down its end
+#   right after sending, like "echo ... | socat", must still have every line
+#   run and answered, even the last one without a newline.
+# * Timeouts, against a scripted controller on a pty: a command that times out
+#   must keep its place in the window until the controller answers something
+#   after it, and a controller that answers nothing must be probed again.
+#
+# Run from anywhere; exits nonzero on failure.
+
+import os
+import pty
+import select
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+import tty
+
+TOP = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def build(tmp):
+    emu = os.path.join(tmp, 'scifidisplay-emu')
+    daemon = os.path.join(tmp, 'scifidisplayd')
+    subprocess.check_call(
+        ['g++', '-std=c++11', '-Wall', '-I.', '-Ihost', '-o', emu,
+         'host/scifidisplay-emu.cpp', 'ScifiDisplay.cpp',
+         'ScifiDisplayBoard.cpp', 'ScifiDisplayRecorder.cpp'], cwd=TOP)
+    subprocess.check_call(
+        ['g++', '-std=c++11', '-Wall', '-o', daemon, 'host/scifidisplayd.cpp'],
+        cwd=TOP)
+    return emu, daemon
+
+
+def wait_for(path):
+    for _ in range(100):
+        if os.path.exists(path):
+            return
+        time.sleep(0.05)
+    raise RuntimeError('%s never appeared' % path)
+
+
+def connect(sock):
+    wait_for(sock)
+    client = socket.socket(socket.AF_UNIX)
+    client.connect(sock)
+    return client.makefile('rw')
+
+
+def wait_ready(f):
+    """Wait for the controller to be probed and ready."""
+    for _ in range(100):
+        f.write('0 i\n')
+        f.flush()
+        if ' up,' in f.readline():
+            return
+        time.sleep(0.05)
+
+
+def emu_commands(log):
+    """Return the commands a scifidisplay-emu -v ran, less probes."""
+    log.seek(0)
+    return [line.split(' ', 1)[1].strip() for line in log
+            if line.strip() and line.split(' ', 1)[1].strip() != 'i']
+
+
+def check_coalescing(emu, daemon, tmp):
+    # (tag, command, expected reply status)
+    burst = [
+        ('a', 'b 1 1', '+'),            # in flight, filling the window
+        ('b', 'm s 1 8 ALERT', '+'),
+        ('c', 'm s 1 8 run away', '+'), # supersedes b
+        ('d', 'l f 1 g', '+'),
+        ('e', 'b 1 9', '-'),            # invalid, so never coalesced
+        ('f', 'm s 1 8 SAFE', '+'),     # supersedes c, must stay last
+        ('g', 'b a 3', '+'),            # doesn't supersede e
+    ]
+    expected_order = ['b 1 1', 'l f 1 g', 'b 1 9', 'm s 1 8 SAFE', 'b a 3']
+
+    link = os.path.join(tmp, 'emu')
+    sock = os.path.join(tmp, 'coalescing.sock')
+    log = open(os.path.join(tmp, 'emu.log'), 'w+')
+
+    procs = [subprocess.Popen([emu, '-v', '-n', '1', '-l', link],
+                              stdout=subprocess.DEVNULL, stderr=log)]
+    try:
+        wait_for(link)
+        procs.append(subprocess.Popen(
+            [daemon, '-s', sock, '-w', '1', link + ':1'],
+            stderr=subprocess.DEVNULL))
+        f = connect(sock)
+        wait_ready(f)
+
+        f.write(''.join('%s %s\n' % (tag, cmd) for tag, cmd, _ in burst))
+        f.flush()
+        replies = {}
+        for _ in burst:
+            tag, status = f.readline().split()[:2]
+            replies[tag] = status
+    finally:
+        for p in reversed(procs):
+            p.terminate()
+            p.wait()
+
+    run = emu_commands(log)
+
+    errors = []
+    if run != expected_order:
+        errors.append('controller ran %r, expected %r' % (run, expected_order))
+    for tag, cmd, status in burst:
+        if replies.get(tag) != status:
+            errors.append('%s %r got %r, expected %r'
+                          % (tag, cmd, replies.get(tag), status))
+    return errors
+
+
+def check_half_close(emu, daemon, tmp):
+    link = os.path.join(tmp, 'emu-half')
+    sock = os.path.join(tmp, 'half-close.sock')
+    log = open(os.path.join(tmp, 'emu-half.log'), 'w+')
+
+    procs = [subprocess.Popen([emu, '-v', '-n', '1', '-l', link],
+                              stdout=subprocess.DEVNULL, stderr=log)]
+    try:
+        wait_for(link)
+        procs.append(subprocess.Popen([daemon, '-s', sock, link + ':1'],
+                                      stderr=subprocess.DEVNULL))
+        f = connect(sock)
+        wait_ready(f)
+        f.close()
+
+        client = socket.socket(socket.AF_UNIX)
+        client.connect(sock)
+        client.sendall(b'x l b 1 r\ny b 1 3')
+        client.shutdown(socket.SHUT_WR)
+        client.settimeout(5)
+        received = b''
+        try:
+            while True:
+                data = client.recv(1024)
+                if not data:
+                    break
+                received += data
+        except socket.timeout:
+            received += b'(no EOF)\n'
+        client.close()
+    finally:
+        for p in reversed(procs):
+            p.terminate()
+            p.wait()
+
+    errors = []
+    replies = sorted(l.split(' ', 2)[:2]
+                     for l in received.decode().splitlines())
+    if replies != [['x', '+'], ['y', '+']]:
+        errors.append('half-closed client got %r' % received)
+    run = emu_commands(log)
+    if run != ['l b 1 r', 'b 1 3']:
+        errors.append('half-closed client ran %r' % run)
+    return errors
+
+
+class FakeController(object):
+    """The controller end of a pty, answering only when told to."""
+
+    def __init__(self):
+        self.master, slave = pty.openpty()
+        tty.setraw(slave)
+        self.path = os.ttyname(slave)
+        self.slave = slave
+        self.rx = b''
+
+    def lines(self, wait):
+        """Return the lines received within wait seconds."""
+        end = time.time() + wait
+        while time.time() < end:
+            if select.select([self.master], [], [], end - time.time())[0]:
+                self.rx += os.read(self.master, 1024)
+        lines = self.rx.split(b'\n')
+        self.rx = lines.pop()
+        return [l.decode() for l in lines]
+
+    def answer(self, line):
+        os.write(self.master, ('%s + ok\r\n' % line.split()[0]).encode())
+
+
+def check_timeouts(daemon, tmp):
+    sock = os.path.join(tmp, 'timeouts.sock')
+    controller = FakeController()
+    errors = []
+
+    # Two 8-byte commands fill a 20-byte window.
+    proc = subprocess.Popen(
+        [daemon, '-s', sock, '-w', '20', '-t', '300', controller.path],
+        stderr=subprocess.DEVNULL)
+    try:
+        probe = controller.lines(1)
+        os.write(controller.master,
+                 ('%s + ScifiDisplay v0.1 num_boards: 4\r\n'
+                  % probe[0].split()[0]).encode())
+        f = connect(sock)
+
+        f.write('a b 1 1\nb b 2 1\n')
+        f.flush()
+        sent = controller.lines(0.1)
+        replies = sorted(f.readline().strip() for _ in range(2))
+        if replies != ['a - %s: Timed out' % controller.path,
+                       'b - %s: Timed out' % controller.path]:
+            errors.append('timeouts replied %r' % replies)
+
+        # The controller hasn't read those yet as far as we know, so the
+        # window is still full.
+        f.write('c b 3 1\n')
+        f.flush()
+        early = controller.lines(0.1)
+        if early:
+            errors.append('%r sent while the window was full' % early)
+
+        # Answering the second shows both were read, opening the window.
+        controller.answer(sent[1])
+        late = controller.lines(0.1)
+        if [l.split(' ', 1)[1] for l in late] != ['b 3 1']:
+            errors.append('after late reply, got %r' % late)
+        else:
+            controller.answer(late[0])
+            reply = f.readline().strip()
+            if reply != 'c + ok':
+                errors.append('c replied %r' % reply)
+
+        # A controller that stops answering altogether gets probed again.
+        f.write('d b 4 1\n')
+        f.flush()
+        lines = controller.lines(1)
+        if [l.split(' ', 1)[1] for l in lines] != ['b 4 1', 'i']:
+            errors.append('silent controller got %r' % lines)
+    finally:
+        proc.terminate()
+        proc.wait()
+    return errors
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        emu, daemon = build(tmp)
+        errors = check_coalescing(emu, daemon, tmp)
+        errors += check_half_close(emu, daemon, tmp)
+        errors += check_timeouts(daemon, tmp)
+
+    for error in errors:
+        print(error)
+    print('FAIL' if errors else 'ok')
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
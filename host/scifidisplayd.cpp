@@ -0,0 +1,923 @@
+/*
+  ScifiDisplay - Arduino library for sci-fi style blinking TM1638 panels
+                 <https://github.com/chazomaticus/scifidisplay>
+  Copyright 2013 Charles Lindsay <chaz@chazomatic.us>
+
+  ScifiDisplay is free software: you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or (at your option) any
+  later version.
+
+  ScifiDisplay is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with ScifiDisplay.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  scifidisplayd - drive many ScifiDisplay controllers from one Linux host
+
+  Each DEVICE is a serial port (or pty) with a controller running
+  examples/scifi_display_daemon, and BOARDS (default 4) is how many TM1638s it
+  has.  Boards are numbered globally in the order given, so with
+  "/dev/ttyACM0:4 /dev/ttyACM1:2" boards 5 and 6 are the second controller's 1
+  and 2.  Build from the top of the source tree with:
+
+    g++ -std=c++11 -O2 -Wall -o scifidisplayd host/scifidisplayd.cpp
+
+  Usage: scifidisplayd [-s SOCKET] [-b BAUD] [-w WINDOW] [-t TIMEOUT]
+                       DEVICE[:BOARDS]...
+
+  Clients connect to the Unix socket SOCKET and send lines of "TAG COMMAND",
+  where TAG is any word and COMMAND is as in ScifiDisplayBase::get_help(),
+  except BOARD is a global board number or a[ll].  Each line gets exactly one
+  reply, "TAG + RESPONSE" or "TAG - RESPONSE", as soon as every controller
+  involved has answered; replies to different tags may come back out of order.
+  "i[nfo]" is answered by the daemon itself.
+
+  Everything runs off a single epoll loop.  Commands are written to every
+  controller as soon as they arrive, up to WINDOW bytes unanswered per
+  controller (default 63, all the Arduino's 64-byte receive ring buffer can
+  hold, since it keeps one slot empty), and matched to replies by an ID the
+  firmware echoes back.  A command still waiting for window space is dropped
+  in favor of a later one that makes it irrelevant, e.g. "b 1 2" for "b a 5",
+  and answered along with it, so a burst of cues never queues up stale work.
+  Commands not answered within TIMEOUT ms (default 3000) fail, but their bytes
+  count against the window until the controller answers something sent later.
+  If it answers nothing for another TIMEOUT, it's probed again as if just
+  opened.
+*/
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// These must agree with ScifiDisplayBase and the example sketch.
+static const size_t MAX_COMMAND_SIZE = 32;
+static const int MAX_BOARDS = 4;
+static const unsigned int MAX_ID = 9999;
+
+// An Arduino's bootloader stays put as long as it hears something at least
+// once a second after a reset, so don't probe any faster than this.
+static const uint64_t PROBE_MILLIS = 1500;
+static const uint64_t REOPEN_MILLIS = 2000;
+static const int TICK_MILLIS = 20;
+
+static const size_t MAX_CLIENT_LINE = 1024;
+
+// epoll tokens; clients are CLIENT_TOKEN + their id.
+static const uint64_t LISTEN_TOKEN = 0;
+static const uint64_t ENDPOINT_TOKEN = 1;
+static const uint64_t CLIENT_TOKEN = 1ull << 32;
+
+static uint64_t now_millis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/// A client's request, which may be fanned out to several controllers.
+struct Request {
+  uint64_t client;
+  std::string tag;
+  int pending;
+  bool ok;
+  std::string response;
+};
+typedef std::shared_ptr<Request> RequestPtr;
+
+/// What part of a controller's state a command overwrites, for coalescing.
+enum Kind {
+  KIND_NONE,
+  KIND_BRIGHTNESS,
+  KIND_MESSAGE_TEXT,
+  KIND_MESSAGE,
+  KIND_LEDS,
+};
+
+struct Key {
+  Kind kind;
+  char board; // '1'-'4' or 'a'
+  char index; // message slot, for KIND_MESSAGE_TEXT
+};
+
+/// A command for one controller, in its local board numbering.
+struct Command {
+  std::string text;
+  Key key;
+  unsigned int id;
+  size_t bytes;
+  uint64_t deadline;
+  std::vector<RequestPtr> waiters;
+};
+
+struct Endpoint {
+  std::string path;
+  int num_boards;
+  int first_board;
+
+  int fd;
+  bool ready;
+  bool warned;
+  unsigned int probe_id;
+  uint64_t next_attempt;
+  unsigned int next_id;
+
+  std::deque<Command> queue;
+  std::deque<Command> in_flight;
+  size_t in_flight_bytes;
+  unsigned long coalesced;
+
+  std::string rx;
+  std::string tx;
+  bool want_write;
+};
+
+struct Client {
+  int fd;
+  std::string rx;
+  std::string tx;
+  bool want_write;
+  bool read_closed;
+  int pending; // requests not yet replied to
+};
+
+static const char* socket_path = "/tmp/scifidisplayd.sock";
+static speed_t baud = B115200;
+static size_t window = 63;
+static uint64_t timeout = 3000;
+
+static int epoll_fd = -1;
+static int listen_fd = -1;
+static std::vector<Endpoint> endpoints;
+static int total_boards = 0;
+static std::map<uint64_t, Client> clients;
+static uint64_t next_client = 0;
+
+static volatile sig_atomic_t quit = 0;
+
+static void on_signal(int) {
+  quit = 1;
+}
+
+static void watch(int fd, uint64_t token, bool want_read, bool want_write, int op) {
+  struct epoll_event ev;
+  ev.events = (want_read ? (uint32_t)EPOLLIN : 0u) | (want_write ? (uint32_t)EPOLLOUT : 0u);
+  ev.data.u64 = token;
+  epoll_ctl(epoll_fd, op, fd, &ev);
+}
+
+/// Split into words the same way the firmware's next_word() does.
+static std::vector<std::pair<size_t, size_t> > split_words(const std::string& s) {
+  std::vector<std::pair<size_t, size_t> > words;
+  size_t i = 0;
+  while(i < s.size()) {
+    while(i < s.size() && s[i] == ' ')
+      ++i;
+    if(i == s.size())
+      break;
+    size_t start = i;
+    while(i < s.size() && s[i] != ' ')
+      ++i;
+    words.push_back(std::make_pair(start, i));
+  }
+  return words;
+}
+
+static bool in_range(char c, char min, char max) {
+  return (c >= min && c <= max);
+}
+
+static bool is_color(char c) {
+  c = (char)tolower(c);
+  return (c == 'r' || c == 'g');
+}
+
+/**
+ * Work out what state a local command overwrites.  Anything that isn't
+ * obviously valid is KIND_NONE and is never coalesced, so the controller gets
+ * to reject it.
+ */
+static Key command_key(const std::string& text) {
+  Key key = { KIND_NONE, 0, 0 };
+  std::vector<std::pair<size_t, size_t> > words = split_words(text);
+  size_t argc = words.size();
+  if(argc < 2)
+    return key;
+
+  char w[5] = { 0, 0, 0, 0, 0 };
+  for(size_t i = 0; i < argc && i < 5; ++i)
+    w[i] = text[words[i].first];
+
+  switch(tolower(w[0])) {
+    case 'b':
+      if(argc == 3 && in_range(w[2], '0', '8')) {
+        key.kind = KIND_BRIGHTNESS;
+        key.board = w[1];
+      }
+      break;
+
+    case 'm':
+      // The text is the rest of the line, spaces and all.
+      if(argc >= 5 && tolower(w[1]) == 's' && in_range(w[3], '1', '8')) {
+        key.kind = KIND_MESSAGE_TEXT;
+        key.board = w[2];
+        key.index = w[3];
+      }
+      else if((argc == 4 && tolower(w[1]) == 'f' && in_range(w[3], '1', '8'))
+          || (argc == 3 && tolower(w[1]) == 'd')) {
+        key.kind = KIND_MESSAGE;
+        key.board = w[2];
+      }
+      break;
+
+    case 'l':
+      if((argc == 4 && (tolower(w[1]) == 'b' || tolower(w[1]) == 'f') && is_color(w[3]))
+          || (argc == 3 && tolower(w[1]) == 'd')) {
+        key.kind = KIND_LEDS;
+        key.board = w[2];
+      }
+      break;
+  }
+
+  key.board = (char)tolower(key.board);
+  return key;
+}
+
+/// Return whether running a command with key a makes one with key b moot.
+static bool supersedes(const Key& a, const Key& b) {
+  return (a.kind != KIND_NONE && a.kind == b.kind
+      && (a.board == 'a' || a.board == b.board)
+      && (a.kind != KIND_MESSAGE_TEXT || a.index == b.index));
+}
+
+static void client_flush(uint64_t id);
+
+static void reply(const Request& request) {
+  std::map<uint64_t, Client>::iterator it = clients.find(request.client);
+  if(it == clients.end())
+    return;
+
+  Client& client = it->second;
+  --client.pending;
+  client.tx += request.tag;
+  client.tx += (request.ok ? " + " : " - ");
+  client.tx += request.response;
+  client.tx += '\n';
+  client_flush(request.client);
+}
+
+static void respond(const RequestPtr& request, bool ok, const std::string& response) {
+  // Report the first failure, or else the last success.
+  if(request->ok) {
+    request->ok = ok;
+    request->response = response;
+  }
+  if(--request->pending == 0)
+    reply(*request);
+}
+
+static void finish(const Endpoint& endpoint, Command& command, bool ok,
+    const std::string& response) {
+  std::string text = (ok ? response : endpoint.path + ": " + response);
+  for(size_t i = 0; i < command.waiters.size(); ++i)
+    respond(command.waiters[i], ok, text);
+  command.waiters.clear();
+}
+
+static void endpoint_close(Endpoint& endpoint, const char* reason) {
+  if(endpoint.fd >= 0) {
+    fprintf(stderr, "%s: %s\n", endpoint.path.c_str(), reason);
+    close(endpoint.fd);
+  }
+  endpoint.fd = -1;
+  endpoint.ready = false;
+  endpoint.next_attempt = now_millis() + REOPEN_MILLIS;
+
+  std::deque<Command> lost;
+  lost.swap(endpoint.in_flight);
+  lost.insert(lost.end(), endpoint.queue.begin(), endpoint.queue.end());
+  endpoint.queue.clear();
+  endpoint.in_flight_bytes = 0;
+  endpoint.rx.clear();
+  endpoint.tx.clear();
+
+  for(size_t i = 0; i < lost.size(); ++i)
+    finish(endpoint, lost[i], false, "Disconnected");
+}
+
+static void endpoint_flush(Endpoint& endpoint) {
+  while(!endpoint.tx.empty()) {
+    ssize_t n = write(endpoint.fd, endpoint.tx.data(), endpoint.tx.size());
+    if(n < 0) {
+      if(errno == EINTR)
+        continue;
+      if(errno == EAGAIN)
+        break;
+      endpoint_close(endpoint, strerror(errno));
+      return;
+    }
+    endpoint.tx.erase(0, (size_t)n);
+  }
+
+  bool want_write = !endpoint.tx.empty();
+  if(want_write != endpoint.want_write) {
+    endpoint.want_write = want_write;
+    watch(endpoint.fd, ENDPOINT_TOKEN + (uint64_t)(&endpoint - &endpoints[0]), true,
+        want_write, EPOLL_CTL_MOD);
+  }
+}
+
+static unsigned int endpoint_next_id(Endpoint& endpoint) {
+  unsigned int id = endpoint.next_id;
+  endpoint.next_id = (id >= MAX_ID ? 1 : id + 1);
+  return id;
+}
+
+/// Send queued commands while there's room in the window.
+static void endpoint_pump(Endpoint& endpoint) {
+  if(endpoint.fd < 0 || !endpoint.ready)
+    return;
+
+  bool sent = false;
+  while(!endpoint.queue.empty()) {
+    Command& command = endpoint.queue.front();
+
+    char id[16];
+    snprintf(id, sizeof(id), "%u ", endpoint.next_id);
+    std::string line = id + command.text + "\n";
+    if(!endpoint.in_flight.empty() && endpoint.in_flight_bytes + line.size() > window)
+      break;
+
+    command.id = endpoint_next_id(endpoint);
+    command.bytes = line.size();
+    endpoint.tx += line;
+    endpoint.in_flight_bytes += command.bytes;
+    endpoint.in_flight.push_back(command);
+    endpoint.queue.pop_front();
+    sent = true;
+  }
+
+  if(sent)
+    endpoint_flush(endpoint);
+}
+
+static void endpoint_enqueue(Endpoint& endpoint, Command& command) {
+  // Fold any queued commands this one supersedes into it.  It still goes at
+  // the tail: moving it ahead of a command it doesn't supersede could run the
+  // two in the wrong order.
+  std::deque<Command> queue;
+  for(size_t i = 0; i < endpoint.queue.size(); ++i) {
+    Command& queued = endpoint.queue[i];
+    if(!supersedes(command.key, queued.key)) {
+      queue.push_back(queued);
+      continue;
+    }
+
+    command.waiters.insert(command.waiters.end(), queued.waiters.begin(),
+        queued.waiters.end());
+    if(queued.deadline < command.deadline)
+      command.deadline = queued.deadline;
+    ++endpoint.coalesced;
+  }
+
+  queue.push_back(command);
+  endpoint.queue.swap(queue);
+
+  endpoint_pump(endpoint);
+}
+
+static void endpoint_send_probe(Endpoint& endpoint) {
+  endpoint.probe_id = endpoint_next_id(endpoint);
+  char line[32];
+  snprintf(line, sizeof(line), "%u i\n", endpoint.probe_id);
+  endpoint.tx += line;
+  endpoint.next_attempt = now_millis() + PROBE_MILLIS;
+  endpoint_flush(endpoint);
+}
+
+static void endpoint_open(Endpoint& endpoint) {
+  int fd = open(endpoint.path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if(fd < 0) {
+    if(!endpoint.warned)
+      fprintf(stderr, "%s: %s\n", endpoint.path.c_str(), strerror(errno));
+    endpoint.warned = true;
+    endpoint.next_attempt = now_millis() + REOPEN_MILLIS;
+    return;
+  }
+
+  struct termios t;
+  if(tcgetattr(fd, &t) == 0) {
+    cfmakeraw(&t);
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cc[VMIN] = 1;
+    t.c_cc[VTIME] = 0;
+    cfsetispeed(&t, baud);
+    cfsetospeed(&t, baud);
+    tcsetattr(fd, TCSANOW, &t);
+    tcflush(fd, TCIOFLUSH);
+  }
+
+  fprintf(stderr, "%s: opened, probing\n", endpoint.path.c_str());
+  endpoint.fd = fd;
+  endpoint.warned = false;
+  endpoint.want_write = false;
+  watch(fd, ENDPOINT_TOKEN + (uint64_t)(&endpoint - &endpoints[0]), true, false, EPOLL_CTL_ADD);
+
+  // Opening the port resets most Arduinos, so don't send commands until the
+  // sketch is up and answering.
+  endpoint_send_probe(endpoint);
+}
+
+static void endpoint_line(Endpoint& endpoint, const std::string& line) {
+  // "ID + RESPONSE" or "ID - RESPONSE"; ignore anything else, e.g. bootloader
+  // noise.
+  char* end;
+  unsigned long id = strtoul(line.c_str(), &end, 10);
+  size_t pos = (size_t)(end - line.c_str());
+  if(pos == 0 || line.size() < pos + 2 || line[pos] != ' '
+      || (line[pos + 1] != '+' && line[pos + 1] != '-'))
+    return;
+  bool ok = (line[pos + 1] == '+');
+  std::string response = (line.size() > pos + 3 ? line.substr(pos + 3) : "");
+
+  if(!endpoint.ready) {
+    if(id != endpoint.probe_id || !ok)
+      return;
+
+    const char* boards = strstr(response.c_str(), "num_boards: ");
+    if(boards && atoi(boards + 12) != endpoint.num_boards) {
+      fprintf(stderr, "%s: controller has %d boards, not %d\n",
+          endpoint.path.c_str(), atoi(boards + 12), endpoint.num_boards);
+    }
+    fprintf(stderr, "%s: ready\n", endpoint.path.c_str());
+    endpoint.ready = true;
+    endpoint_pump(endpoint);
+    return;
+  }
+
+  size_t i;
+  for(i = 0; i < endpoint.in_flight.size() && endpoint.in_flight[i].id != id; ++i)
+    ;
+  if(i == endpoint.in_flight.size())
+    return; // From before a re-probe.
+
+  // Replies come back in order, so anything sent before this was lost.  This
+  // is also where timed out commands finally leave the window.
+  for(size_t j = 0; j <= i; ++j) {
+    Command command = endpoint.in_flight.front();
+    endpoint.in_flight.pop_front();
+    endpoint.in_flight_bytes -= command.bytes;
+    if(j < i)
+      finish(endpoint, command, false, "No response");
+    else
+      finish(endpoint, command, ok, response);
+  }
+
+  endpoint_pump(endpoint);
+}
+
+static void endpoint_read(Endpoint& endpoint) {
+  char buf[512];
+  for(;;) {
+    ssize_t n = read(endpoint.fd, buf, sizeof(buf));
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n < 0 && errno == EAGAIN)
+      break;
+    if(n <= 0) {
+      endpoint_close(endpoint, (n == 0 ? "closed" : strerror(errno)));
+      return;
+    }
+    endpoint.rx.append(buf, (size_t)n);
+  }
+
+  size_t newline;
+  while(endpoint.fd >= 0 && (newline = endpoint.rx.find('\n')) != std::string::npos) {
+    std::string line = endpoint.rx.substr(0, newline);
+    endpoint.rx.erase(0, newline + 1);
+    if(!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    endpoint_line(endpoint, line);
+  }
+  if(endpoint.rx.size() > MAX_CLIENT_LINE)
+    endpoint.rx.clear();
+}
+
+/// Fail commands that have waited too long, probe and reopen controllers.
+static void tick() {
+  uint64_t now = now_millis();
+
+  for(size_t e = 0; e < endpoints.size(); ++e) {
+    Endpoint& endpoint = endpoints[e];
+
+    if(endpoint.fd < 0) {
+      if(now >= endpoint.next_attempt)
+        endpoint_open(endpoint);
+      continue;
+    }
+    if(!endpoint.ready && now >= endpoint.next_attempt)
+      endpoint_send_probe(endpoint);
+
+    // A command that times out in flight is failed but stays in the window:
+    // its bytes may still be sitting in the controller's receive buffer, and
+    // only a reply to something sent after it shows they've been read.
+    bool waiting = false;
+    for(size_t i = 0; i < endpoint.in_flight.size(); ++i) {
+      Command& command = endpoint.in_flight[i];
+      if(command.deadline <= now)
+        finish(endpoint, command, false, "Timed out");
+      waiting = waiting || !command.waiters.empty();
+    }
+
+    // If nothing has come back for another whole timeout, the controller has
+    // hung or reset.  Start over, and wait for it to answer a probe before
+    // sending anything else.
+    if(!waiting && !endpoint.in_flight.empty()
+        && now >= endpoint.in_flight.back().deadline + timeout) {
+      fprintf(stderr, "%s: not answering, probing\n", endpoint.path.c_str());
+      endpoint.in_flight.clear();
+      endpoint.in_flight_bytes = 0;
+      endpoint.ready = false;
+      endpoint_send_probe(endpoint);
+    }
+
+    std::deque<Command> keep;
+    std::deque<Command> expired;
+    for(size_t i = 0; i < endpoint.queue.size(); ++i) {
+      Command& command = endpoint.queue[i];
+      if(command.deadline > now)
+        keep.push_back(command);
+      else
+        expired.push_back(command);
+    }
+    endpoint.queue.swap(keep);
+    for(size_t i = 0; i < expired.size(); ++i)
+      finish(endpoint, expired[i], false, "Timed out");
+
+    endpoint_pump(endpoint);
+  }
+}
+
+static void client_close(uint64_t id) {
+  std::map<uint64_t, Client>::iterator it = clients.find(id);
+  if(it == clients.end())
+    return;
+  close(it->second.fd);
+  clients.erase(it);
+}
+
+static void client_flush(uint64_t id) {
+  Client& client = clients[id];
+  while(!client.tx.empty()) {
+    ssize_t n = send(client.fd, client.tx.data(), client.tx.size(), MSG_NOSIGNAL);
+    if(n < 0) {
+      if(errno == EINTR)
+        continue;
+      if(errno == EAGAIN)
+        break;
+      client_close(id);
+      return;
+    }
+    client.tx.erase(0, (size_t)n);
+  }
+
+  // A client that's done sending is closed once it has all its replies.
+  if(client.read_closed && client.pending == 0 && client.tx.empty()) {
+    client_close(id);
+    return;
+  }
+
+  bool want_write = !client.tx.empty();
+  if(want_write != client.want_write) {
+    client.want_write = want_write;
+    watch(client.fd, CLIENT_TOKEN + id, !client.read_closed, want_write, EPOLL_CTL_MOD);
+  }
+}
+
+static std::string info() {
+  std::string s = "scifidisplayd boards: ";
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%d", total_boards);
+  s += buf;
+  for(size_t e = 0; e < endpoints.size(); ++e) {
+    const Endpoint& endpoint = endpoints[e];
+    snprintf(buf, sizeof(buf), "; %d-%d %s %s, %lu coalesced",
+        endpoint.first_board, endpoint.first_board + endpoint.num_boards - 1,
+        endpoint.path.c_str(),
+        (endpoint.fd < 0 ? "down" : endpoint.ready ? "up" : "probing"),
+        endpoint.coalesced);
+    s += buf;
+  }
+  return s;
+}
+
+static void client_line(uint64_t client, const std::string& line) {
+  RequestPtr request(new Request);
+  request->client = client;
+  request->pending = 1;
+  request->ok = false;
+
+  std::vector<std::pair<size_t, size_t> > words = split_words(line);
+  if(words.empty())
+    return;
+  request->tag = line.substr(words[0].first, words[0].second - words[0].first);
+  ++clients[client].pending;
+  if(words.size() < 2) {
+    request->response = "Missing command";
+    reply(*request);
+    return;
+  }
+
+  std::string command = line.substr(words[1].first);
+  words = split_words(command);
+  char name = command[0];
+  char buf[64];
+
+  size_t board_word;
+  switch(tolower(name)) {
+    case 'i':
+      request->ok = true;
+      request->response = info();
+      reply(*request);
+      return;
+
+    case 'b':
+      board_word = 1;
+      break;
+
+    case 'm': case 'l':
+      board_word = 2;
+      break;
+
+    default:
+      snprintf(buf, sizeof(buf), "Unknown command %c", (isprint(name) ? name : ' '));
+      request->response = buf;
+      reply(*request);
+      return;
+  }
+
+  // Translate the global board into each controller's local numbering.
+  std::vector<std::pair<Endpoint*, char> > targets;
+  if(words.size() > board_word) {
+    size_t start = words[board_word].first;
+    size_t end = words[board_word].second;
+    if(tolower(command[start]) == 'a') {
+      for(size_t e = 0; e < endpoints.size(); ++e)
+        targets.push_back(std::make_pair(&endpoints[e], 'a'));
+    }
+    else {
+      char* num_end;
+      long board = strtol(command.c_str() + start, &num_end, 10);
+      for(size_t e = 0; (size_t)(num_end - command.c_str()) == end
+          && e < endpoints.size(); ++e) {
+        Endpoint& endpoint = endpoints[e];
+        if(board >= endpoint.first_board && board < endpoint.first_board + endpoint.num_boards)
+          targets.push_back(std::make_pair(&endpoint, (char)('1' + board - endpoint.first_board)));
+      }
+    }
+  }
+  if(targets.empty()) {
+    snprintf(buf, sizeof(buf), "Invalid args for command %c", name);
+    request->response = buf;
+    reply(*request);
+    return;
+  }
+
+  std::string prefix = command.substr(0, words[board_word].first);
+  std::string suffix = command.substr(words[board_word].second);
+  if(prefix.size() + 1 + suffix.size() >= MAX_COMMAND_SIZE) {
+    request->response = "Command too long";
+    reply(*request);
+    return;
+  }
+
+  uint64_t deadline = now_millis() + timeout;
+  request->ok = true;
+  request->pending = (int)targets.size();
+  for(size_t t = 0; t < targets.size(); ++t) {
+    Endpoint& endpoint = *targets[t].first;
+
+    Command local;
+    local.text = prefix + targets[t].second + suffix;
+    local.key = command_key(local.text);
+    local.id = 0;
+    local.bytes = 0;
+    local.deadline = deadline;
+    local.waiters.push_back(request);
+
+    if(endpoint.fd < 0)
+      finish(endpoint, local, false, "Not connected");
+    else
+      endpoint_enqueue(endpoint, local);
+  }
+}
+
+static void client_read(uint64_t id) {
+  Client& client = clients[id];
+  char buf[512];
+  bool eof = false;
+  for(;;) {
+    ssize_t n = recv(client.fd, buf, sizeof(buf), 0);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n < 0 && errno == EAGAIN)
+      break;
+    if(n < 0) {
+      client_close(id);
+      return;
+    }
+    if(n == 0) {
+      eof = true;
+      break;
+    }
+    client.rx.append(buf, (size_t)n);
+  }
+
+  // A client may shut down its end right after sending, as in
+  // "echo ... | socat", so run what it sent and stay open for the replies.
+  if(eof && !client.rx.empty() && client.rx[client.rx.size() - 1] != '\n')
+    client.rx += '\n';
+
+  size_t newline;
+  while(clients.count(id) && (newline = clients[id].rx.find('\n')) != std::string::npos) {
+    std::string line = clients[id].rx.substr(0, newline);
+    clients[id].rx.erase(0, newline + 1);
+    if(!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    client_line(id, line);
+  }
+  if(!clients.count(id))
+    return;
+  if(clients[id].rx.size() > MAX_CLIENT_LINE) {
+    client_close(id);
+    return;
+  }
+
+  if(eof) {
+    Client& closing = clients[id];
+    closing.read_closed = true;
+    watch(closing.fd, CLIENT_TOKEN + id, false, closing.want_write, EPOLL_CTL_MOD);
+    client_flush(id);
+  }
+}
+
+static void client_accept() {
+  int fd;
+  while((fd = accept4(listen_fd, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    uint64_t id = next_client++;
+    Client& client = clients[id];
+    client.fd = fd;
+    client.want_write = false;
+    client.read_closed = false;
+    client.pending = 0;
+    watch(fd, CLIENT_TOKEN + id, true, false, EPOLL_CTL_ADD);
+  }
+}
+
+static speed_t parse_baud(const char* s) {
+  static const struct { long rate; speed_t speed; } rates[] = {
+    { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 },
+    { 115200, B115200 }, { 230400, B230400 }, { 460800, B460800 },
+    { 500000, B500000 }, { 1000000, B1000000 }, { 2000000, B2000000 },
+  };
+  long rate = atol(s);
+  for(size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+    if(rates[i].rate == rate)
+      return rates[i].speed;
+  }
+  return B0;
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+      "Usage: %s [-s SOCKET] [-b BAUD] [-w WINDOW] [-t TIMEOUT] DEVICE[:BOARDS]...\n",
+      argv0);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  while((opt = getopt(argc, argv, "s:b:w:t:")) != -1) {
+    switch(opt) {
+      case 's': socket_path = optarg; break;
+      case 'b': baud = parse_baud(optarg); break;
+      case 'w': window = (size_t)atol(optarg); break;
+      case 't': timeout = (uint64_t)atol(optarg); break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind == argc || baud == B0 || window == 0 || timeout == 0)
+    usage(argv[0]);
+
+  for(int i = optind; i < argc; ++i) {
+    Endpoint endpoint = Endpoint();
+    endpoint.path = argv[i];
+    endpoint.num_boards = MAX_BOARDS;
+    size_t colon = endpoint.path.rfind(':');
+    if(colon != std::string::npos && colon + 2 == endpoint.path.size()
+        && in_range(endpoint.path[colon + 1], '1', '0' + MAX_BOARDS)) {
+      endpoint.num_boards = endpoint.path[colon + 1] - '0';
+      endpoint.path.erase(colon);
+    }
+    endpoint.first_board = total_boards + 1;
+    endpoint.fd = -1;
+    endpoint.next_id = 1;
+    total_boards += endpoint.num_boards;
+    endpoints.push_back(endpoint);
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, 0);
+  sigaction(SIGTERM, &sa, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(socket_path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: path too long\n", socket_path);
+    return 1;
+  }
+  strcpy(addr.sun_path, socket_path);
+  unlink(socket_path);
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+      || listen(listen_fd, 16) < 0) {
+    perror(socket_path);
+    return 1;
+  }
+  watch(listen_fd, LISTEN_TOKEN, true, false, EPOLL_CTL_ADD);
+
+  for(size_t e = 0; e < endpoints.size(); ++e)
+    endpoint_open(endpoints[e]);
+
+  uint64_t next_tick = now_millis() + TICK_MILLIS;
+  while(!quit) {
+    struct epoll_event events[64];
+    uint64_t now = now_millis();
+    int wait = (next_tick > now ? (int)(next_tick - now) : 0);
+    int n = epoll_wait(epoll_fd, events, 64, wait);
+    if(n < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      break;
+    }
+
+    for(int i = 0; i < n; ++i) {
+      uint64_t token = events[i].data.u64;
+      uint32_t ev = events[i].events;
+
+      if(token == LISTEN_TOKEN)
+        client_accept();
+      else if(token >= CLIENT_TOKEN) {
+        uint64_t id = token - CLIENT_TOKEN;
+        if(clients.count(id) && (ev & EPOLLOUT))
+          client_flush(id);
+        if(clients.count(id) && clients[id].read_closed && (ev & (EPOLLHUP | EPOLLERR)))
+          client_close(id); // gone entirely, so nobody to reply to
+        else if(clients.count(id) && (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+          client_read(id);
+      }
+      else {
+        Endpoint& endpoint = endpoints[token - ENDPOINT_TOKEN];
+        if(endpoint.fd >= 0 && (ev & EPOLLOUT))
+          endpoint_flush(endpoint);
+        if(endpoint.fd >= 0 && (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+          endpoint_read(endpoint);
+      }
+    }
+
+    if(now_millis() >= next_tick) {
+      tick();
+      next_tick = now_millis() + TICK_MILLIS;
+    }
+  }
+
+  unlink(socket_path);
+  return 0;
+}